@@ -76,11 +76,31 @@ protected:
         module_manager().add_module(
             std::make_unique<HeartbeatModule>(module_enabled("heartbeat")));
 
-        create_workers(*this);
+        create_workers(*this, rate_limits_.get());
 
         start_http_server(loop, settings().server_port);
         logger().info("worker ready (pid={}, port={})", ::getpid(), http_port());
     }
+
+    // The RateLimit zone is mapped once the config is loaded and before any
+    // worker is forked, so that every worker shares it. Respawned workers
+    // inherit the existing zone.
+    void spawn_workers() override
+    {
+        if (!rate_limits_)
+            rate_limits_ = RateLimit::create_zone(*this);
+        Application::spawn_workers();
+    }
+
+    void single_run() override
+    {
+        if (!rate_limits_)
+            rate_limits_ = RateLimit::create_zone(*this);
+        Application::single_run();
+    }
+
+private:
+    std::unique_ptr<RateLimitZone> rate_limits_;
 };
 
 int main(int argc, char* argv[])
@@ -0,0 +1,441 @@
+#include "RateLimit/RateLimit.hpp"
+
+#include "apostol/application.hpp"
+#include "apostol/http_utils.hpp"
+
+#ifdef WITH_SSL
+#include "apostol/jwt.hpp"
+#endif
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+
+#include <sys/mman.h>
+
+namespace apostol
+{
+
+namespace
+{
+
+std::int64_t steady_now_ns()
+{
+    // CLOCK_MONOTONIC is system-wide, so every worker reads the same timeline.
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// FNV-1a finished with the murmur3 mixer so that the low bits used for the
+// slot index are well distributed.
+std::uint64_t hash64(std::uint64_t seed, std::string_view data)
+{
+    std::uint64_t h = 14695981039346656037ULL;
+    auto mix = [&h](unsigned char c) { h = (h ^ c) * 1099511628211ULL; };
+
+    for (std::size_t i = 0; i < sizeof(seed); ++i)
+        mix(static_cast<unsigned char>(seed >> (i * 8)));
+    for (char c : data)
+        mix(static_cast<unsigned char>(c));
+
+    h ^= h >> 33; h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+
+    return h;
+}
+
+std::uint64_t fingerprint(std::size_t rule, std::string_view key)
+{
+    const auto h = hash64(rule, key);
+    return h != 0 ? h : 1;   // 0 marks an empty slot
+}
+
+std::string_view trim(std::string_view s)
+{
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back()  == ' ' || s.back()  == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+bool iequals(std::string_view a, std::string_view b)
+{
+    return a.size() == b.size()
+        && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return std::tolower(static_cast<unsigned char>(x))
+                   == std::tolower(static_cast<unsigned char>(y));
+           });
+}
+
+bool is_count(const nlohmann::json& v)
+{
+    return v.is_number_unsigned() || (v.is_number_integer() && v.get<std::int64_t>() >= 0);
+}
+
+} // anonymous namespace
+
+// ─── RateLimitZone ───────────────────────────────────────────────────────────
+
+RateLimitZone::RateLimitZone(std::size_t slots)
+{
+    slots  = std::bit_ceil(std::clamp(slots, k_probe, k_max_slots));
+    mask_  = slots - 1;
+    bytes_ = slots * sizeof(Slot);
+
+    void* mem = ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED)
+        throw std::system_error(errno, std::generic_category(), "RateLimitZone: mmap");
+
+    slots_ = new (mem) Slot[slots];
+}
+
+RateLimitZone::~RateLimitZone()
+{
+    if (slots_)
+        ::munmap(slots_, bytes_);
+}
+
+RateLimitZone::Slot* RateLimitZone::find_slot(std::uint64_t key, std::int64_t now_ns)
+{
+    Slot*         candidate = nullptr;
+    std::uint64_t seen      = 0;
+
+    for (std::size_t i = 0; i < k_probe; ++i) {
+        Slot& s = slots_[(key + i) & mask_];
+        auto  k = s.key.load(std::memory_order_acquire);
+
+        if (k == key)
+            return &s;
+
+        // Empty, or a bucket that has fully refilled and can change owner.
+        if (!candidate && (k == 0 || s.tat.load(std::memory_order_relaxed) <= now_ns)) {
+            candidate = &s;
+            seen      = k;
+        }
+    }
+
+    if (!candidate)
+        return nullptr;
+
+    if (candidate->key.compare_exchange_strong(seen, key, std::memory_order_acq_rel)) {
+        // Start the new owner from a full bucket. A worker that loaded the old
+        // owner's tat before the handover fails its CAS against this store,
+        // reloads and charges one interval here — at most one stray request per
+        // racing worker, at the moment the old bucket was idle anyway. Packing
+        // key and tat into a 128-bit CAS would close that window but is not
+        // lock-free on every target; the tolerance is accepted instead.
+        candidate->tat.store(now_ns, std::memory_order_relaxed);
+        return candidate;
+    }
+
+    // Lost the race: fine if the winner was another request for the same key.
+    return seen == key ? candidate : nullptr;
+}
+
+RateLimitZone::Decision RateLimitZone::acquire(std::uint64_t key, std::int64_t now_ns,
+                                               std::int64_t interval_ns,
+                                               std::int64_t tolerance_ns)
+{
+    Slot* slot = find_slot(key, now_ns);
+    if (!slot)
+        return {};
+
+    auto tat = slot->tat.load(std::memory_order_relaxed);
+    for (;;) {
+        const auto base = std::max(tat, now_ns);
+        if (base - now_ns > tolerance_ns)
+            return {false, base - now_ns - tolerance_ns};
+
+        if (slot->tat.compare_exchange_weak(tat, base + interval_ns,
+                                            std::memory_order_relaxed))
+            return {};
+    }
+}
+
+// ─── RateLimit ───────────────────────────────────────────────────────────────
+
+std::unique_ptr<RateLimitZone> RateLimit::create_zone(Application& app)
+{
+    const auto* cfg = app.module_config("RateLimit");
+    if (!cfg || !cfg->is_object())
+        return nullptr;
+
+    const auto enable = cfg->find("enable");
+    if (enable == cfg->end() || !enable->is_boolean() || !enable->get<bool>())
+        return nullptr;
+
+    auto slots = RateLimitZone::k_default_slots;
+
+    if (const auto it = cfg->find("zone_slots"); it != cfg->end()) {
+        if (is_count(*it) && it->get<std::uint64_t>() > 0) {
+            slots = static_cast<std::size_t>(
+                std::min<std::uint64_t>(it->get<std::uint64_t>(), RateLimitZone::k_max_slots));
+        } else {
+            app.logger().warn("RateLimit: zone_slots must be a positive integer — using {}",
+                              slots);
+        }
+    }
+
+    auto zone = std::make_unique<RateLimitZone>(slots);
+    app.logger().info("RateLimit: shared zone of {} slots ({} KiB)",
+                      zone->slots(), zone->bytes() / 1024);
+    return zone;
+}
+
+RateLimit::RateLimit(Application& app, RateLimitZone& zone)
+    : app_(app)
+    , zone_(zone)
+{
+    const auto* cfg = app.module_config("RateLimit");
+    if (!cfg || !cfg->is_object())
+        return;
+
+    auto& log = app.logger();
+
+    if (const auto it = cfg->find("proxy_hops"); it != cfg->end()) {
+        if (is_count(*it))
+            proxy_hops_ = it->get<std::size_t>();
+        else
+            log.warn("RateLimit: proxy_hops must be a non-negative integer — using {}",
+                     proxy_hops_);
+    }
+
+    if (const auto it = cfg->find("real_ip_header"); it != cfg->end()) {
+        const auto header = it->is_string() ? it->get<std::string>() : std::string();
+        if (iequals(header, "X-Real-IP")) {
+            ip_source_ = IpSource::real_ip;
+        } else if (iequals(header, "X-Forwarded-For")) {
+            ip_source_ = IpSource::forwarded_for;
+        } else {
+            ip_source_ = IpSource::none;
+            log.warn("RateLimit: real_ip_header must be \"X-Real-IP\" or \"X-Forwarded-For\""
+                     " — rules are refused");
+        }
+    }
+
+#ifdef WITH_SSL
+    if (const auto it = cfg->find("oauth2"); it != cfg->end()) {
+        if (it->is_string())
+            providers_.load(app.resolve_path(it->get<std::string>(), "oauth2"));
+        else
+            log.warn("RateLimit: oauth2 must be a path string — Bearer tokens are not verified");
+    }
+#endif
+
+    const auto rules = cfg->find("rules");
+    if (rules == cfg->end())
+        return;
+
+    if (!rules->is_array()) {
+        log.warn("RateLimit: rules must be an array — rate limiting is disabled");
+        return;
+    }
+
+    for (std::size_t i = 0; i < rules->size(); ++i) {
+        const auto& r = (*rules)[i];
+
+        auto invalid = [&](std::string_view field, std::string_view why) {
+            log.warn("RateLimit: rules[{}].{} {} — rule ignored", i, field, why);
+        };
+
+        if (!r.is_object()) {
+            log.warn("RateLimit: rules[{}] must be an object — rule ignored", i);
+            continue;
+        }
+
+        Rule rule;
+
+        const auto endpoints = r.find("endpoints");
+        if (endpoints == r.end() || !endpoints->is_array() || endpoints->empty()
+            || !std::all_of(endpoints->begin(), endpoints->end(),
+                            [](const auto& e) { return e.is_string(); }))
+        {
+            invalid("endpoints", "must be a non-empty array of path patterns");
+            continue;
+        }
+        rule.endpoints = endpoints->get<std::vector<std::string>>();
+
+        const auto key = r.find("key");
+        if (key == r.end() || !key->is_string()) {
+            invalid("key", "must be \"ip\" or \"auth\"");
+            continue;
+        }
+        if (*key == "ip") {
+            rule.key = Key::ip;
+        } else if (*key == "auth") {
+            rule.key = Key::auth;
+        } else {
+            invalid("key", fmt::format("\"{}\" is unknown (expected \"ip\" or \"auth\")",
+                                       key->get<std::string>()));
+            continue;
+        }
+        // "auth" charges every request without a verified subject to the
+        // client address, so both keys need one.
+        if (proxy_hops_ == 0) {
+            invalid("key", "needs proxy_hops >= 1 (the peer address is not visible to modules)");
+            continue;
+        }
+        if (ip_source_ == IpSource::none) {
+            invalid("key", "needs a valid real_ip_header");
+            continue;
+        }
+
+        const auto rate = r.find("rate");
+        if (rate == r.end() || !rate->is_number() || !(rate->get<double>() > 0)) {
+            invalid("rate", "must be a positive number of requests per second");
+            continue;
+        }
+
+        double burst = 0;
+        if (const auto b = r.find("burst"); b != r.end()) {
+            if (!b->is_number() || !(b->get<double>() >= 0)) {
+                invalid("burst", "must be a non-negative number");
+                continue;
+            }
+            burst = b->get<double>();
+        }
+
+        rule.interval_ns  = std::max<std::int64_t>(1, std::llround(1e9 / rate->get<double>()));
+        rule.tolerance_ns = std::llround(static_cast<double>(rule.interval_ns) * burst);
+
+        rules_.push_back(std::move(rule));
+    }
+}
+
+bool RateLimit::enabled() const
+{
+    return app_.module_enabled("RateLimit") && !rules_.empty();
+}
+
+bool RateLimit::execute(const HttpRequest& req, HttpResponse& resp)
+{
+    const auto now = steady_now_ns();
+
+    for (std::size_t i = 0; i < rules_.size(); ++i) {
+        const auto& rule = rules_[i];
+        if (!match_path(req.path, rule.endpoints))
+            continue;
+
+        std::string subject;
+        if (rule.key == Key::auth)
+            subject = auth_subject(std::string(req.header("Authorization")));
+
+        if (subject.empty()) {
+            const auto ip = client_ip(req);
+            if (ip.empty()) {
+                reply_error(resp, 403, "client address unavailable");
+                return true;
+            }
+            subject = "ip:" + ip;
+        }
+
+        const auto d = zone_.acquire(fingerprint(i, subject), now,
+                                     rule.interval_ns, rule.tolerance_ns);
+        if (d.allowed)
+            continue;
+
+        const auto retry_after = std::max<std::int64_t>(
+            1, (d.retry_after_ns + 999'999'999) / 1'000'000'000);
+
+        reply_error(resp, 429, "too many requests");
+        resp.set_header("Retry-After", std::to_string(retry_after));
+        return true;
+    }
+
+    return false;
+}
+
+std::string RateLimit::client_ip(const HttpRequest& req) const
+{
+    if (proxy_hops_ == 0)
+        return {};
+
+    // Only the configured header is read. A proxy that sets one of them passes
+    // the other through as the client sent it, so falling back would let the
+    // client pick its own address.
+    switch (ip_source_) {
+        case IpSource::real_ip:
+            return std::string(trim(std::string(get_real_ip(req))));
+
+        case IpSource::forwarded_for:
+            break;
+
+        case IpSource::none:
+            return {};
+    }
+
+    // Walk X-Forwarded-For from the right: the last proxy_hops entries were
+    // appended by our proxies, the left-most of those is the client.
+    std::string xff(req.header("X-Forwarded-For"));
+    std::string_view rest = xff;
+
+    for (std::size_t hop = 1; !trim(rest).empty(); ++hop) {
+        const auto comma = rest.rfind(',');
+        const auto entry = trim(comma == std::string_view::npos ? rest : rest.substr(comma + 1));
+
+        if (hop == proxy_hops_)
+            return std::string(entry);
+        if (comma == std::string_view::npos)
+            break;
+
+        rest = rest.substr(0, comma);
+    }
+
+    // Fewer entries than trusted proxies: the request bypassed one of them.
+    return {};
+}
+
+std::string RateLimit::auth_subject(std::string_view authorization) const
+{
+    authorization = trim(authorization);
+    if (authorization.empty())
+        return {};
+
+#ifdef WITH_SSL
+    constexpr std::string_view bearer = "bearer ";
+    if (authorization.size() > bearer.size()
+        && std::equal(bearer.begin(), bearer.end(), authorization.begin(),
+                      [](char a, char b) {
+                          return a == std::tolower(static_cast<unsigned char>(b));
+                      }))
+    {
+        const std::string token(trim(authorization.substr(bearer.size())));
+        const auto        now = steady_now_ns();
+
+        if (const auto it = verified_.find(token); it != verified_.end()) {
+            if (it->second.expires_ns > now)
+                return it->second.subject;
+            verified_.erase(it);
+        }
+
+        try {
+            const auto claims = verify_jwt(token, providers_);
+            if (!claims.sub.empty()) {
+                // Only accepted tokens are stored, so junk cannot grow the cache.
+                if (verified_.size() >= k_verified_max)
+                    verified_.clear();
+
+                auto subject = "sub:" + claims.sub;
+                verified_.emplace(token, Verified{subject, now + k_verified_ttl_ns});
+                return subject;
+            }
+        } catch (const std::exception&) {
+            // Forged, expired or unknown-audience token — charged to the client address.
+        }
+    }
+#endif
+
+    return {};
+}
+
+} // namespace apostol
@@ -0,0 +1,213 @@
+#pragma once
+
+// ─── RateLimit.hpp ───────────────────────────────────────────────────────────
+//
+// Per-IP / per-subject request rate limiting for Worker processes.
+//
+// Limits are GCRA buckets ("generic cell rate algorithm", equivalent to a token
+// bucket) stored in a RateLimitZone — an anonymous MAP_SHARED mapping created
+// by the master after the config is loaded and before workers are forked, so
+// every SO_REUSEPORT worker sees the same counters. Each bucket is a pair of
+// atomics updated with CAS; there is no lock on the request path.
+//
+// The module is registered first in create_workers() and only ever answers with
+// an error; a request under the limit falls through to the next module (PGHTTP,
+// WebServer) untouched, so rejected calls never reach PgPool.
+//
+// Configuration (module.RateLimit):
+//
+//   "RateLimit": {
+//     "enable": true,
+//     "zone_slots": 65536,
+//     "proxy_hops": 1,
+//     "real_ip_header": "X-Real-IP",
+//     "oauth2": "oauth2",
+//     "rules": [
+//       { "endpoints": ["/api/*"],         "key": "ip",   "rate": 100, "burst": 200 },
+//       { "endpoints": ["/api/v1/sign*"],  "key": "auth", "rate": 1,   "burst": 5   }
+//     ]
+//   }
+//
+//   zone_slots     — buckets in the shared zone (16 bytes each, rounded up to
+//                    a power of two); read once, when the first worker is spawned
+//   proxy_hops     — trusted reverse proxies in front of the server (default 1)
+//   real_ip_header — the one header the client address is read from:
+//                    "X-Real-IP" (default) or "X-Forwarded-For"
+//   oauth2         — OAuth 2.0 providers directory used to verify Bearer tokens
+//   endpoints      — match_path() patterns the rule applies to
+//   key            — "ip" or "auth" (see below)
+//   rate           — sustained requests per second
+//   burst          — extra requests allowed on top of the sustained rate
+//
+// Keys:
+//
+//   ip   — Modules never see the connection itself, so the client address is
+//          taken from real_ip_header, and from that header only — a proxy that
+//          sets one passes the other through as the client sent it:
+//            X-Real-IP       — via get_real_ip(); the proxy next to the server
+//                              must overwrite it (nginx: $remote_addr).
+//            X-Forwarded-For — the entry proxy_hops places from the right; each
+//                              proxy appends the peer it received the request
+//                              from, entries further left come from the client.
+//          The listen port must therefore be reachable only through the proxy.
+//          With proxy_hops = 0 or an unknown real_ip_header no client address
+//          is available and every rule is refused.
+//
+//   auth — "sub" claim of a Bearer JWT whose signature verify_jwt() accepts.
+//          Every other request — anonymous, or carrying a credential that does
+//          not verify (forged, expired, opaque, Basic) — is charged to its
+//          client address as for "ip", so rotating credentials neither buys a
+//          fresh bucket nor fills the zone. Without WITH_SSL no token can be
+//          verified and "auth" behaves as "ip".
+//
+//          Cost: verification (RS256 for most providers) runs on the loop
+//          thread, ahead of PGHTTP's own check of the same token. Accepted
+//          tokens are cached per worker for k_verified_ttl_ns, so a client
+//          re-sending its token pays once; a token that fails is verified on
+//          every request. Keep "auth" endpoints narrow.
+//
+// A request a rule applies to but for which no client address can be
+// determined is rejected with 403 — it did not come through the trusted proxy.
+
+#include "apostol/http.hpp"
+#include "apostol/module.hpp"
+
+#ifdef WITH_SSL
+#include "apostol/oauth_providers.hpp"
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace apostol
+{
+
+class Application;
+
+// ─── RateLimitZone ───────────────────────────────────────────────────────────
+
+/// Fixed-size table of GCRA buckets in memory shared across fork().
+///
+/// Keys are 64-bit fingerprints; collisions are resolved by a short linear
+/// probe. A bucket whose theoretical arrival time is in the past is full again
+/// and may be handed over to another key. When every probed slot is live the
+/// request is allowed (fail open) rather than limited by a stranger's bucket;
+/// size the zone for the expected number of concurrently active keys.
+///
+/// Buckets are exact per key except at a handover: a worker still charging the
+/// previous owner can land one interval on the new owner (see find_slot()).
+class RateLimitZone
+{
+public:
+    static constexpr std::size_t k_default_slots = 65536;      // 1 MiB
+    static constexpr std::size_t k_max_slots     = 1u << 24;   // 256 MiB
+    static constexpr std::size_t k_probe         = 4;
+
+    struct Decision
+    {
+        bool          allowed{true};
+        std::int64_t  retry_after_ns{0};
+    };
+
+    /// Map the zone. Must be called before workers are forked.
+    /// @p slots is clamped to [k_probe, k_max_slots] and rounded up to a power of two.
+    explicit RateLimitZone(std::size_t slots = k_default_slots);
+    ~RateLimitZone();
+
+    RateLimitZone(const RateLimitZone&)            = delete;
+    RateLimitZone& operator=(const RateLimitZone&) = delete;
+
+    /// Account one request for @p key at @p now_ns (steady clock).
+    /// @p interval_ns is 1/rate, @p tolerance_ns is interval_ns * burst.
+    Decision acquire(std::uint64_t key, std::int64_t now_ns,
+                     std::int64_t interval_ns, std::int64_t tolerance_ns);
+
+    std::size_t slots() const { return mask_ + 1; }
+    std::size_t bytes() const { return bytes_; }
+
+private:
+    struct Slot
+    {
+        std::atomic<std::uint64_t> key{0};
+        std::atomic<std::int64_t>  tat{0};   // theoretical arrival time, ns
+    };
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+    static_assert(std::atomic<std::int64_t>::is_always_lock_free);
+
+    Slot* find_slot(std::uint64_t key, std::int64_t now_ns);
+
+    Slot*       slots_{nullptr};
+    std::size_t mask_{0};
+    std::size_t bytes_{0};
+};
+
+// ─── RateLimit ───────────────────────────────────────────────────────────────
+
+class RateLimit final : public Module
+{
+public:
+    RateLimit(Application& app, RateLimitZone& zone);
+
+    /// Map the shared zone if module.RateLimit.enable is true, sized by
+    /// zone_slots; nullptr otherwise. Call after the config is loaded and
+    /// before workers are forked.
+    static std::unique_ptr<RateLimitZone> create_zone(Application& app);
+
+    std::string_view name()    const override { return "RateLimit"; }
+
+    /// module.RateLimit.enable is true and at least one rule is valid.
+    bool             enabled() const override;
+
+    bool execute(const HttpRequest& req, HttpResponse& resp) override;
+
+    /// Client address as described above ("ip" key); empty if unknown.
+    std::string client_ip(const HttpRequest& req) const;
+
+    /// Bucket key for an Authorization value: "sub:<sub>" for a verified JWT,
+    /// empty otherwise (the request is charged to client_ip()).
+    std::string auth_subject(std::string_view authorization) const;
+
+private:
+    enum class Key { ip, auth };
+    enum class IpSource { real_ip, forwarded_for, none };
+
+    struct Rule
+    {
+        std::vector<std::string> endpoints;
+        Key                      key{Key::ip};
+        std::int64_t             interval_ns{0};
+        std::int64_t             tolerance_ns{0};
+    };
+
+    Application&      app_;
+    RateLimitZone&    zone_;
+    std::vector<Rule> rules_;
+    std::size_t       proxy_hops_{1};
+    IpSource          ip_source_{IpSource::real_ip};
+
+#ifdef WITH_SSL
+    // Verified Bearer tokens → bucket key. JwtClaims carries no exp, so an
+    // entry lives briefly and may outlast its token by up to the TTL — that
+    // only keeps the request on its subject's bucket, PGHTTP still rejects it.
+    struct Verified
+    {
+        std::string  subject;
+        std::int64_t expires_ns{0};
+    };
+
+    static constexpr std::int64_t k_verified_ttl_ns = 30'000'000'000;
+    static constexpr std::size_t  k_verified_max    = 4096;
+
+    OAuthProviders    providers_;
+    mutable std::unordered_map<std::string, Verified> verified_;
+#endif
+};
+
+} // namespace apostol
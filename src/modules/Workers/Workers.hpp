@@ -8,6 +8,8 @@
 
 #include "apostol/application.hpp"
 
+#include "RateLimit/RateLimit.hpp"
+
 #ifdef WITH_POSTGRESQL
 #include "PGHTTP/PGHTTP.hpp"
 #endif
@@ -18,8 +20,14 @@ namespace apostol
 {
 
 /// Instantiate and register all Worker modules with the module manager.
-static inline void create_workers(Application& app)
+/// @p rate_limits is the shared zone the master created before forking,
+/// or nullptr when RateLimit is disabled.
+static inline void create_workers(Application& app, RateLimitZone* rate_limits)
 {
+    // RateLimit — first in chain, rejects before any module touches PgPool
+    if (rate_limits)
+        app.module_manager().add_module(std::make_unique<RateLimit>(app, *rate_limits));
+
 #ifdef WITH_POSTGRESQL
     if (app.module_enabled("PGHTTP") && app.has_db_pool())
         app.module_manager().add_module(std::make_unique<PGHTTP>(app));
@@ -0,0 +1,597 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "RateLimit/RateLimit.hpp"
+#include "apostol/application.hpp"
+#include "apostol/http.hpp"
+
+#ifdef WITH_SSL
+#define JWT_DISABLE_PICOJSON
+#include "jwt-cpp/traits/nlohmann-json/traits.h"
+#endif
+
+#include <nlohmann/json.hpp>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+
+using namespace apostol;
+
+// ─── Helpers ──────────────────────────────────────────────────────────────────
+
+namespace
+{
+
+constexpr std::int64_t k_sec = 1'000'000'000;
+
+// 10 req/s, burst 2 → three back-to-back requests pass, the fourth is limited.
+constexpr std::int64_t k_interval  = k_sec / 10;
+constexpr std::int64_t k_tolerance = k_interval * 2;
+
+class TestApp : public Application
+{
+public:
+    TestApp() : Application("test-rate-limit")
+    {
+        settings_.pid_file = std::filesystem::temp_directory_path()
+                             / ("apostol-test-rl-" + std::to_string(::getpid()) + ".pid");
+    }
+
+    ~TestApp() override
+    {
+        std::error_code ec;
+        std::filesystem::remove(settings_.pid_file, ec);
+    }
+};
+
+// Temp config file, removed on scope exit (including failed REQUIREs).
+struct TempConfig
+{
+    std::filesystem::path path = std::filesystem::temp_directory_path()
+                                 / ("ratelimit-cfg-" + std::to_string(::getpid()) + ".json");
+
+    explicit TempConfig(const nlohmann::json& rate_limit)
+    {
+        std::ofstream f(path);
+        f << nlohmann::json{{"module", {{"RateLimit", rate_limit}}}}.dump();
+    }
+
+    ~TempConfig()
+    {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+};
+
+// Load @p rate_limit as module.RateLimit into @p app via -t -c <file>.
+void load_config(TestApp& app, const nlohmann::json& rate_limit)
+{
+    TempConfig cfg(rate_limit);
+    std::string prog = "test-rate-limit";
+    std::string flag_t = "-t";
+    std::string flag_c = "-c";
+    std::string cfg_path = cfg.path.string();
+    char* argv[] = { prog.data(), flag_t.data(), flag_c.data(), cfg_path.data(), nullptr };
+    REQUIRE(app.run(4, argv) == 0);
+}
+
+HttpRequest make_request(std::string path,
+                         std::vector<std::pair<std::string, std::string>> headers = {})
+{
+    HttpRequest req;
+    req.method  = "GET";
+    req.path    = std::move(path);
+    req.version = "HTTP/1.1";
+    req.headers = std::move(headers);
+    return req;
+}
+
+// A "rules" array holding a single rule.
+nlohmann::json one_rule(const std::string& endpoint, const std::string& key,
+                        double rate, double burst)
+{
+    return nlohmann::json::array({nlohmann::json::object({
+        {"endpoints", nlohmann::json::array({endpoint})},
+        {"key",       key},
+        {"rate",      rate},
+        {"burst",     burst},
+    })});
+}
+
+int status_of(const HttpResponse& resp)
+{
+    auto s = resp.serialize();
+    return std::stoi(s.substr(s.find(' ') + 1, 3));
+}
+
+} // anonymous namespace
+
+// ─── RateLimitZone ────────────────────────────────────────────────────────────
+
+TEST_CASE("RateLimitZone: burst is allowed, then requests are limited", "[rate_limit]")
+{
+    RateLimitZone zone(64);
+    const std::int64_t now = 100 * k_sec;
+
+    CHECK(zone.acquire(42, now, k_interval, k_tolerance).allowed);
+    CHECK(zone.acquire(42, now, k_interval, k_tolerance).allowed);
+    CHECK(zone.acquire(42, now, k_interval, k_tolerance).allowed);
+
+    auto d = zone.acquire(42, now, k_interval, k_tolerance);
+    CHECK_FALSE(d.allowed);
+    CHECK(d.retry_after_ns == k_interval);
+}
+
+TEST_CASE("RateLimitZone: bucket refills with time", "[rate_limit]")
+{
+    RateLimitZone zone(64);
+    std::int64_t now = 100 * k_sec;
+
+    for (int i = 0; i < 3; ++i)
+        REQUIRE(zone.acquire(7, now, k_interval, k_tolerance).allowed);
+    REQUIRE_FALSE(zone.acquire(7, now, k_interval, k_tolerance).allowed);
+
+    now += k_interval;
+    CHECK(zone.acquire(7, now, k_interval, k_tolerance).allowed);
+    CHECK_FALSE(zone.acquire(7, now, k_interval, k_tolerance).allowed);
+}
+
+TEST_CASE("RateLimitZone: keys are limited independently", "[rate_limit]")
+{
+    RateLimitZone zone(64);
+    const std::int64_t now = 100 * k_sec;
+
+    for (int i = 0; i < 3; ++i)
+        REQUIRE(zone.acquire(1, now, k_interval, k_tolerance).allowed);
+    REQUIRE_FALSE(zone.acquire(1, now, k_interval, k_tolerance).allowed);
+
+    CHECK(zone.acquire(2, now, k_interval, k_tolerance).allowed);
+}
+
+TEST_CASE("RateLimitZone: slot count is clamped and rounded to a power of two", "[rate_limit]")
+{
+    CHECK(RateLimitZone(1).slots()    == RateLimitZone::k_probe);
+    CHECK(RateLimitZone(1000).slots() == 1024);
+    CHECK(RateLimitZone(1000).bytes() == 1024 * 2 * sizeof(std::uint64_t));
+    CHECK(RateLimitZone(RateLimitZone::k_max_slots * 4).slots() == RateLimitZone::k_max_slots);
+}
+
+TEST_CASE("RateLimitZone: full probe window fails open, expired slot changes owner", "[rate_limit]")
+{
+    // A 4-slot zone is exactly one probe window: every key competes for it.
+    RateLimitZone zone(RateLimitZone::k_probe);
+    std::int64_t now = 100 * k_sec;
+
+    for (std::uint64_t key = 1; key <= RateLimitZone::k_probe; ++key)
+        REQUIRE(zone.acquire(key, now, k_interval, k_tolerance).allowed);
+
+    // No free slot — the fifth key is never limited.
+    for (int i = 0; i < 10; ++i)
+        CHECK(zone.acquire(99, now, k_interval, k_tolerance).allowed);
+
+    // Once the other buckets refill, the fifth key takes one over with a full
+    // bucket of its own and is limited from then on.
+    now += k_sec;
+    for (int i = 0; i < 3; ++i)
+        REQUIRE(zone.acquire(99, now, k_interval, k_tolerance).allowed);
+    CHECK_FALSE(zone.acquire(99, now, k_interval, k_tolerance).allowed);
+}
+
+TEST_CASE("RateLimitZone: counters are shared with forked children", "[rate_limit]")
+{
+    RateLimitZone zone(64);
+    const std::int64_t now = 100 * k_sec;
+
+    pid_t child = ::fork();
+    REQUIRE(child >= 0);
+    if (child == 0) {
+        for (int i = 0; i < 3; ++i)
+            zone.acquire(5, now, k_interval, k_tolerance);
+        ::_exit(0);
+    }
+
+    int status = 0;
+    REQUIRE(::waitpid(child, &status, 0) == child);
+    REQUIRE(WIFEXITED(status));
+
+    CHECK_FALSE(zone.acquire(5, now, k_interval, k_tolerance).allowed);
+}
+
+// ─── create_zone ──────────────────────────────────────────────────────────────
+
+TEST_CASE("RateLimit: create_zone maps nothing unless enabled", "[rate_limit]")
+{
+    SECTION("no config")
+    {
+        TestApp app;
+        CHECK(RateLimit::create_zone(app) == nullptr);
+    }
+
+    SECTION("enable: false")
+    {
+        TestApp app;
+        load_config(app, {{"enable", false}, {"zone_slots", 1024}});
+        CHECK(RateLimit::create_zone(app) == nullptr);
+    }
+
+    SECTION("enable is not a boolean")
+    {
+        TestApp app;
+        load_config(app, {{"enable", "yes"}});
+        CHECK(RateLimit::create_zone(app) == nullptr);
+    }
+}
+
+TEST_CASE("RateLimit: create_zone is sized by zone_slots", "[rate_limit]")
+{
+    TestApp app;
+
+    SECTION("configured")
+    {
+        load_config(app, {{"enable", true}, {"zone_slots", 1000}});
+        auto zone = RateLimit::create_zone(app);
+        REQUIRE(zone);
+        CHECK(zone->slots() == 1024);
+    }
+
+    SECTION("invalid value falls back to the default")
+    {
+        load_config(app, {{"enable", true}, {"zone_slots", "big"}});
+        auto zone = RateLimit::create_zone(app);
+        REQUIRE(zone);
+        CHECK(zone->slots() == RateLimitZone::k_default_slots);
+    }
+}
+
+// ─── Rule validation ──────────────────────────────────────────────────────────
+
+TEST_CASE("RateLimit: invalid rules are ignored without throwing", "[rate_limit]")
+{
+    const auto api = nlohmann::json::array({"/api/*"});
+
+    TestApp app;
+    load_config(app, {
+        {"enable", true},
+        {"proxy_hops", "one"},
+        {"rules", nlohmann::json::array({
+            "not an object",
+            {{"endpoints", "/api/*"}, {"key", "ip"},     {"rate", 1}},
+            {{"endpoints", api},      {"key", "client"}, {"rate", 1}},
+            {{"endpoints", api},      {"key", 1},        {"rate", 1}},
+            {{"endpoints", api},      {"key", "ip"},     {"rate", 0}},
+            {{"endpoints", api},      {"key", "ip"},     {"rate", "10"}},
+            {{"endpoints", api},      {"key", "ip"},     {"rate", 1}, {"burst", -1}},
+        })},
+    });
+
+    RateLimitZone zone(64);
+    std::unique_ptr<RateLimit> mod;
+    REQUIRE_NOTHROW(mod = std::make_unique<RateLimit>(app, zone));
+    CHECK_FALSE(mod->enabled());
+}
+
+TEST_CASE("RateLimit: rules are refused without a trusted proxy", "[rate_limit]")
+{
+    RateLimitZone zone(64);
+
+    for (const char* key : {"ip", "auth"}) {
+        TestApp app;
+        load_config(app, {
+            {"enable", true},
+            {"proxy_hops", 0},
+            {"rules", one_rule("/api/*", key, 1, 0)},
+        });
+
+        RateLimit mod(app, zone);
+        CHECK_FALSE(mod.enabled());
+    }
+}
+
+TEST_CASE("RateLimit: module follows module.RateLimit.enable", "[rate_limit]")
+{
+    TestApp app;
+    RateLimitZone zone(64);
+
+    SECTION("enabled")
+    {
+        load_config(app, {{"enable", true}, {"rules", one_rule("/api/*", "ip", 1, 0)}});
+        CHECK(RateLimit(app, zone).enabled());
+    }
+
+    SECTION("disabled, even with valid rules and a zone")
+    {
+        load_config(app, {{"enable", false}, {"rules", one_rule("/api/*", "ip", 1, 0)}});
+        CHECK_FALSE(RateLimit(app, zone).enabled());
+    }
+}
+
+// ─── Client address ───────────────────────────────────────────────────────────
+
+TEST_CASE("RateLimit: client_ip reads only real_ip_header", "[rate_limit]")
+{
+    TestApp app;
+    RateLimitZone zone(64);
+
+    SECTION("X-Real-IP by default; X-Forwarded-For is ignored")
+    {
+        load_config(app, {{"proxy_hops", 1}});
+        RateLimit mod(app, zone);
+
+        CHECK(mod.client_ip(make_request("/", {{"X-Real-IP", "10.0.0.2"}})) == "10.0.0.2");
+        CHECK(mod.client_ip(make_request("/", {{"X-Real-IP", "10.0.0.2"},
+                                                {"X-Forwarded-For", "6.6.6.6"}})) == "10.0.0.2");
+        CHECK(mod.client_ip(make_request("/", {{"X-Forwarded-For", "6.6.6.6"}})).empty());
+        CHECK(mod.client_ip(make_request("/")).empty());
+    }
+
+    SECTION("X-Forwarded-For, one proxy: right-most entry; X-Real-IP is ignored")
+    {
+        load_config(app, {{"proxy_hops", 1}, {"real_ip_header", "x-forwarded-for"}});
+        RateLimit mod(app, zone);
+
+        CHECK(mod.client_ip(make_request("/", {{"X-Forwarded-For", "10.0.0.1"}})) == "10.0.0.1");
+        CHECK(mod.client_ip(make_request("/", {{"X-Forwarded-For", "6.6.6.6, 10.0.0.1"}})) == "10.0.0.1");
+        CHECK(mod.client_ip(make_request("/", {{"X-Forwarded-For", "10.0.0.1"},
+                                                {"X-Real-IP", "10.0.0.99"}})) == "10.0.0.1");
+        CHECK(mod.client_ip(make_request("/", {{"X-Real-IP", "10.0.0.2"}})).empty());
+    }
+
+    SECTION("X-Forwarded-For, two proxies: second entry from the right")
+    {
+        load_config(app, {{"proxy_hops", 2}, {"real_ip_header", "X-Forwarded-For"}});
+        RateLimit mod(app, zone);
+
+        CHECK(mod.client_ip(make_request("/", {{"X-Forwarded-For", "6.6.6.6, 10.0.0.1, 172.16.0.1"}}))
+              == "10.0.0.1");
+        CHECK(mod.client_ip(make_request("/", {{"X-Forwarded-For", "172.16.0.1"}})).empty());
+    }
+
+    SECTION("unknown real_ip_header refuses ip rules")
+    {
+        load_config(app, {
+            {"enable", true},
+            {"real_ip_header", "Forwarded"},
+            {"rules", one_rule("/api/*", "ip", 1, 0)},
+        });
+        RateLimit mod(app, zone);
+
+        CHECK(mod.client_ip(make_request("/", {{"X-Real-IP", "10.0.0.2"}})).empty());
+        CHECK_FALSE(mod.enabled());
+    }
+}
+
+// ─── RateLimit module ─────────────────────────────────────────────────────────
+
+TEST_CASE("RateLimit: per-IP rule", "[rate_limit]")
+{
+    TestApp app;
+    load_config(app, {
+        {"enable", true},
+        {"real_ip_header", "X-Forwarded-For"},
+        {"rules", one_rule("/api/*", "ip", 1, 1)},
+    });
+
+    RateLimitZone zone(64);
+    RateLimit mod(app, zone);
+    REQUIRE(mod.enabled());
+
+    SECTION("over-limit requests get 429 with Retry-After")
+    {
+        auto req = make_request("/api/v1/ping", {{"X-Forwarded-For", "10.0.0.1"}});
+        HttpResponse resp;
+
+        CHECK_FALSE(mod.execute(req, resp));
+        CHECK_FALSE(mod.execute(req, resp));
+
+        REQUIRE(mod.execute(req, resp));
+        CHECK(status_of(resp) == 429);
+        CHECK(resp.serialize().find("Retry-After: 1") != std::string::npos);
+
+        // Another client is unaffected
+        HttpResponse other;
+        CHECK_FALSE(mod.execute(make_request("/api/v1/ping", {{"X-Forwarded-For", "10.0.0.2"}}), other));
+    }
+
+    SECTION("forged left-most X-Forwarded-For hops do not escape the limit")
+    {
+        HttpResponse resp;
+        CHECK_FALSE(mod.execute(make_request("/api/x", {{"X-Forwarded-For", "1.1.1.1, 10.0.0.3"}}), resp));
+        CHECK_FALSE(mod.execute(make_request("/api/x", {{"X-Forwarded-For", "2.2.2.2, 10.0.0.3"}}), resp));
+        REQUIRE(mod.execute(make_request("/api/x", {{"X-Forwarded-For", "3.3.3.3, 10.0.0.3"}}), resp));
+        CHECK(status_of(resp) == 429);
+    }
+
+    SECTION("forged victim address does not drain the victim's bucket")
+    {
+        HttpResponse resp;
+        for (int i = 0; i < 5; ++i)
+            mod.execute(make_request("/api/x", {{"X-Real-IP", "10.0.0.4"},
+                                                {"X-Forwarded-For", "10.0.0.4, 10.0.0.66"}}), resp);
+
+        HttpResponse victim;
+        CHECK_FALSE(mod.execute(make_request("/api/x", {{"X-Forwarded-For", "10.0.0.4"}}), victim));
+    }
+
+    SECTION("request without a client address is rejected")
+    {
+        HttpResponse resp;
+        REQUIRE(mod.execute(make_request("/api/v1/ping", {{"Accept", "*/*"}}), resp));
+        CHECK(status_of(resp) == 403);
+    }
+
+    SECTION("unmatched path is not limited")
+    {
+        HttpResponse resp;
+        for (int i = 0; i < 5; ++i)
+            CHECK_FALSE(mod.execute(make_request("/static/app.js"), resp));
+    }
+}
+
+TEST_CASE("RateLimit: forged X-Forwarded-For behind an X-Real-IP proxy is ignored", "[rate_limit]")
+{
+    TestApp app;
+    load_config(app, {
+        {"enable", true},
+        {"real_ip_header", "X-Real-IP"},
+        {"rules", one_rule("/api/*", "ip", 1, 1)},
+    });
+
+    RateLimitZone zone(64);
+    RateLimit mod(app, zone);
+
+    // The proxy overwrites X-Real-IP and passes the client's X-Forwarded-For on.
+    HttpResponse resp;
+    CHECK_FALSE(mod.execute(make_request("/api/x", {{"X-Real-IP", "10.0.0.7"},
+                                                    {"X-Forwarded-For", "1.1.1.1"}}), resp));
+    CHECK_FALSE(mod.execute(make_request("/api/x", {{"X-Real-IP", "10.0.0.7"},
+                                                    {"X-Forwarded-For", "2.2.2.2"}}), resp));
+    REQUIRE(mod.execute(make_request("/api/x", {{"X-Real-IP", "10.0.0.7"},
+                                                {"X-Forwarded-For", "3.3.3.3"}}), resp));
+    CHECK(status_of(resp) == 429);
+}
+
+TEST_CASE("RateLimit: unverified credentials are charged to the client address", "[rate_limit]")
+{
+    TestApp app;
+    load_config(app, {
+        {"enable", true},
+        {"rules", one_rule("/auth", "auth", 1, 1)},
+    });
+
+    RateLimitZone zone(64);
+    RateLimit mod(app, zone);
+    REQUIRE(mod.enabled());
+
+    CHECK(mod.auth_subject("").empty());
+    CHECK(mod.auth_subject("Basic dXNlcjpwYXNz").empty());
+    CHECK(mod.auth_subject("Bearer opaque-token").empty());
+
+    SECTION("rotated junk tokens from one address are limited")
+    {
+        HttpResponse resp;
+        for (int i = 0; i < 2; ++i)
+            CHECK_FALSE(mod.execute(make_request("/auth", {
+                {"X-Real-IP", "10.0.0.5"},
+                {"Authorization", "Bearer junk-" + std::to_string(i)}}), resp));
+
+        REQUIRE(mod.execute(make_request("/auth", {
+            {"X-Real-IP", "10.0.0.5"},
+            {"Authorization", "Bearer junk-2"}}), resp));
+        CHECK(status_of(resp) == 429);
+
+        // Another client is unaffected
+        HttpResponse other;
+        CHECK_FALSE(mod.execute(make_request("/auth", {
+            {"X-Real-IP", "10.0.0.6"},
+            {"Authorization", "Bearer junk-3"}}), other));
+    }
+
+    SECTION("Basic, Bearer and anonymous requests share the address bucket")
+    {
+        HttpResponse resp;
+        CHECK_FALSE(mod.execute(make_request("/auth", {
+            {"X-Real-IP", "10.0.0.5"},
+            {"Authorization", "Basic dXNlcjpwYXNz"}}), resp));
+        CHECK_FALSE(mod.execute(make_request("/auth", {{"X-Real-IP", "10.0.0.5"}}), resp));
+        CHECK(mod.execute(make_request("/auth", {
+            {"X-Real-IP", "10.0.0.5"},
+            {"Authorization", "Basic b3RoZXI6cGFzcw=="}}), resp));
+    }
+
+    SECTION("credential without a client address is rejected")
+    {
+        HttpResponse resp;
+        REQUIRE(mod.execute(make_request("/auth", {{"Authorization", "Bearer junk"}}), resp));
+        CHECK(status_of(resp) == 403);
+    }
+}
+
+#ifdef WITH_SSL
+
+namespace
+{
+
+using jwt_traits = jwt::traits::nlohmann_json;
+
+// OAuth 2.0 providers directory, removed on scope exit.
+struct TempProviders
+{
+    std::filesystem::path path = std::filesystem::temp_directory_path()
+                                 / ("apostol_test_rl_oauth2_" + std::to_string(::getpid()));
+
+    TempProviders()
+    {
+        std::filesystem::create_directories(path);
+        std::ofstream f(path / "default.json");
+        f << R"({"web": {"client_id": "rl-client", "client_secret": "rl-secret"}})";
+    }
+
+    ~TempProviders()
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+    }
+};
+
+std::string make_token(const std::string& secret, const std::string& sub, int iat_offset = 0)
+{
+    auto now = std::chrono::system_clock::now() + std::chrono::seconds(iat_offset);
+    return jwt::create<jwt_traits>()
+        .set_algorithm("HS256")
+        .set_issuer("test-issuer")
+        .set_audience("rl-client")
+        .set_subject(sub)
+        .set_issued_at(now)
+        .set_expires_at(now + std::chrono::hours(1))
+        .sign(jwt::algorithm::hs256{secret});
+}
+
+} // anonymous namespace
+
+TEST_CASE("RateLimit: verified JWT subject shares one bucket, forged token does not", "[rate_limit]")
+{
+    TempProviders providers;
+    TestApp app;
+    load_config(app, {
+        {"enable", true},
+        {"oauth2", providers.path.string()},
+        {"rules", one_rule("/auth", "auth", 1, 0)},
+    });
+
+    RateLimitZone zone(64);
+    RateLimit mod(app, zone);
+
+    const auto victim  = make_token("rl-secret", "victim");
+    const auto victim2 = make_token("rl-secret", "victim", -5);
+    const auto forged  = make_token("attacker-secret", "victim");
+
+    CHECK(mod.auth_subject("Bearer " + victim)  == "sub:victim");
+    CHECK(mod.auth_subject("bearer " + victim2) == "sub:victim");
+    CHECK(mod.auth_subject("Bearer " + forged).empty());
+
+    SECTION("forged token cannot drain the victim's bucket")
+    {
+        HttpResponse resp;
+        for (int i = 0; i < 3; ++i)
+            mod.execute(make_request("/auth", {{"X-Real-IP", "10.0.0.66"},
+                                               {"Authorization", "Bearer " + forged}}), resp);
+
+        HttpResponse ok;
+        CHECK_FALSE(mod.execute(make_request("/auth", {{"Authorization", "Bearer " + victim}}), ok));
+    }
+
+    SECTION("tokens of the same subject share the bucket")
+    {
+        HttpResponse resp;
+        CHECK_FALSE(mod.execute(make_request("/auth", {{"Authorization", "Bearer " + victim}}), resp));
+        REQUIRE(mod.execute(make_request("/auth", {{"Authorization", "Bearer " + victim2}}), resp));
+        CHECK(status_of(resp) == 429);
+    }
+}
+
+#endif // WITH_SSL